@@ -0,0 +1,136 @@
+// Producer-side latency of logging a concatenation: synchronous operator S()
+// followed by write(2), against fsc_async_sink::push(). Writes to /dev/null
+// unless a path is given.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../fast_string_concatenator.hpp"
+#include "../fsc_async_sink.hpp"
+
+using namespace stlsoft;
+using string_class = std::string;
+
+namespace
+{
+    constexpr std::size_t records = 200000;
+
+    void report(char const* name, std::vector<double>& ns)
+    {
+        std::sort(ns.begin(), ns.end());
+        auto const at = [&ns](double q) { return ns[static_cast<std::size_t>(q * static_cast<double>(ns.size() - 1))]; };
+        std::printf("%-8s %10.0f %10.0f %10.0f %10.0f %10.0f\n", name, at(0.5), at(0.9), at(0.99), at(0.999), ns.back());
+    }
+
+    // Pushes through a buffer small enough to wrap and fill, then reads the file back
+    bool verify()
+    {
+        std::FILE* const file = std::tmpfile();
+        if (nullptr == file)
+        {
+            std::perror("tmpfile");
+            return false;
+        }
+
+        string_class const module = "net.session";
+        string_class expected;
+        {
+            fsc_async_sink sink(::fileno(file), 256);
+            auto const log_one = [&sink, &expected](auto const& fsc)
+            {
+                expected += string_class(fsc);
+                while (!sink.push(fsc))
+                {
+                    std::this_thread::yield();
+                }
+            };
+
+            for (std::size_t i = 0; i < 10000; ++i)
+            {
+                log_one(fsc_seed() + module + ": request " + std::to_string(i) + '\n');
+            }
+            sink.flush();
+        }
+
+        string_class actual(expected.size() + 1, '\0');
+        std::rewind(file);
+        actual.resize(std::fread(&actual[0], 1, actual.size(), file));
+        std::fclose(file);
+
+        if (actual != expected)
+        {
+            std::printf("fsc_async_sink wrote %zu bytes, expected %zu\n", actual.size(), expected.size());
+            return false;
+        }
+        return true;
+    }
+
+    template <class F>
+    std::vector<double> measure(F&& log_one)
+    {
+        string_class const level = "INFO";
+        string_class const module = "net.session";
+        string_class id;
+        std::vector<double> ns(records);
+
+        for (std::size_t i = 0; i < records; ++i)
+        {
+            id = std::to_string(i);
+            auto const start = std::chrono::steady_clock::now();
+            log_one(fsc_seed() + level + ' ' + module + ": request " + id + " completed in " + module + '\n');
+            ns[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+        return ns;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (!verify())
+    {
+        return 1;
+    }
+
+    char const* const path = (argc > 1) ? argv[1] : "/dev/null";
+    int const fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::perror(path);
+        return 1;
+    }
+
+    std::printf("%zu records to %s, latency in ns\n", records, path);
+    std::printf("%-8s %10s %10s %10s %10s %10s\n", "", "p50", "p90", "p99", "p99.9", "max");
+
+    auto sync = measure([fd](auto const& fsc)
+    {
+        string_class const s = fsc;
+        if (::write(fd, s.data(), s.size()) < 0)
+        {
+            std::perror("write");
+        }
+    });
+    report("sync", sync);
+
+    {
+        fsc_async_sink sink(fd);
+        auto async = measure([&sink](auto const& fsc)
+        {
+            while (!sink.push(fsc))
+            {
+                std::this_thread::yield();
+            }
+        });
+        sink.flush();
+        report("async", async);
+        std::printf("async pushes retried on a full buffer: %zu\n", sink.full());
+    }
+
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,234 @@
+// Compares string concatenation strategies over sweeps of fragment count,
+// fragment length and literal-vs-string mix. Prints one CSV row per
+// (sweep point, strategy) on stdout:
+//
+//   sweep,count,length,literal_pct,strategy,ns_per_op,bytes_per_op,allocs_per_op
+//
+// Allocation columns are empty unless built with instrumentation
+// (SAMPLE_WITH_INSTRUMENTATION, the default).
+
+#define FSC_INSTRUMENT_REPLACE_NEW
+#include "../fsc_instrument.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../fast_string_concatenator.hpp"
+
+using namespace stlsoft;
+using string_class = std::string;
+
+namespace
+{
+    /// One operand of the concatenation: a string object or a literal
+    struct fragment
+    {
+        string_class    str;
+        bool            literal;
+    };
+
+    struct point
+    {
+        char const*     sweep;
+        std::size_t     count;
+        std::size_t     length;
+        std::size_t     literal_pct;
+    };
+
+    std::vector<fragment> make_fragments(point const& p)
+    {
+        std::vector<fragment> fragments;
+        for (std::size_t i = 0; i < p.count; ++i)
+        {
+            // Spread the literals evenly through the expression
+            bool const literal = (i + 1) * p.literal_pct / 100 != i * p.literal_pct / 100;
+            fragments.push_back({string_class(p.length, static_cast<char>('a' + i % 26)), literal});
+        }
+        return fragments;
+    }
+
+    // Runtime-length equivalents of a single `a + b + c ...` expression; every
+    // intermediate concatenator stays alive on the stack until the result is built
+
+    template <class A>
+    string_class fold(A const& acc, std::vector<fragment> const& fragments, std::size_t i)
+    {
+        if (i == fragments.size())
+        {
+            return acc;
+        }
+        auto const& f = fragments[i];
+        return f.literal ? fold(acc + f.str.c_str(), fragments, i + 1)
+                         : fold(acc + f.str, fragments, i + 1);
+    }
+
+    string_class naive_plus(std::vector<fragment> const& fragments)
+    {
+        string_class r = fragments[0].literal ? string_class(fragments[0].str.c_str()) : fragments[0].str;
+        for (std::size_t i = 1; i < fragments.size(); ++i)
+        {
+            auto const& f = fragments[i];
+            r = f.literal ? std::move(r) + f.str.c_str() : std::move(r) + f.str;
+        }
+        return r;
+    }
+
+    string_class reserve_append(std::vector<fragment> const& fragments)
+    {
+        std::size_t len = 0;
+        for (auto const& f : fragments)
+        {
+            len += f.literal ? std::strlen(f.str.c_str()) : f.str.size();
+        }
+        string_class r;
+        r.reserve(len);
+        for (auto const& f : fragments)
+        {
+            if (f.literal)
+            {
+                r.append(f.str.c_str());
+            }
+            else
+            {
+                r.append(f.str);
+            }
+        }
+        return r;
+    }
+
+    string_class ostringstream_shift(std::vector<fragment> const& fragments)
+    {
+        std::ostringstream os;
+        for (auto const& f : fragments)
+        {
+            if (f.literal)
+            {
+                os << f.str.c_str();
+            }
+            else
+            {
+                os << f.str;
+            }
+        }
+        return os.str();
+    }
+
+    // fsc_seed is untyped, so there is no fsc_seed() + C string operator; a literal first operand
+    // is seeded through the constructor instead
+
+    string_class fsc_stack(std::vector<fragment> const& fragments)
+    {
+        auto const& f = fragments[0];
+        if (f.literal)
+        {
+            return fold(fast_string_concatenator<string_class>(fsc_seed(), f.str.c_str()), fragments, 1);
+        }
+        return fold(fsc_seed() + f.str, fragments, 1);
+    }
+
+    string_class fsc_arena(std::vector<fragment> const& fragments)
+    {
+        concat_arena<string_class> arena;
+        auto const& f = fragments[0];
+        if (f.literal)
+        {
+            return fold(fsc_safe_seed(arena) + f.str.c_str(), fragments, 1);
+        }
+        return fold(fsc_safe_seed(arena) + f.str, fragments, 1);
+    }
+
+    struct strategy
+    {
+        char const*     name;
+        string_class    (*run)(std::vector<fragment> const&);
+    };
+
+    strategy const strategies[] =
+    {
+            {"naive_plus",      naive_plus}
+        ,   {"reserve_append",  reserve_append}
+        ,   {"ostringstream",   ostringstream_shift}
+        ,   {"fsc_seed",        fsc_stack}
+        ,   {"fsc_safe_seed",   fsc_arena}
+    };
+
+    std::size_t sink = 0;
+
+    void measure(point const& p, strategy const& s)
+    {
+        auto const fragments = make_fragments(p);
+        string_class const expected = reserve_append(fragments);
+        if (s.run(fragments) != expected)
+        {
+            std::fprintf(stderr, "%s: wrong result\n", s.name);
+            std::exit(1);
+        }
+
+        // Size a batch to roughly a millisecond, then keep the best of several batches
+        std::size_t ops = 1;
+        for (;;)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                sink += s.run(fragments).size();
+            }
+            if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(1) || ops >= (1u << 24))
+            {
+                break;
+            }
+            ops *= 2;
+        }
+
+        double best = 1e300;
+        for (int batch = 0; batch < 7; ++batch)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                sink += s.run(fragments).size();
+            }
+            std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count() / static_cast<double>(ops));
+        }
+
+        std::printf("%s,%zu,%zu,%zu,%s,%.1f,", p.sweep, p.count, p.length, p.literal_pct, s.name, best);
+#if defined(FSC_INSTRUMENT)
+        fsc_instrument::scope region;
+        sink += s.run(fragments).size();
+        std::printf("%zu,%zu\n", region.delta().bytes_allocated, region.delta().allocations);
+#else
+        std::printf(",\n");
+#endif
+    }
+}
+
+int main()
+{
+    std::vector<point> points;
+    for (std::size_t count : {2, 4, 8, 16, 32, 64})
+    {
+        points.push_back({"count", count, 8, 0});
+    }
+    for (std::size_t length : {1, 4, 16, 64, 256, 1024})
+    {
+        points.push_back({"length", 8, length, 0});
+    }
+    for (std::size_t pct : {0, 25, 50, 75, 100})
+    {
+        points.push_back({"literal_mix", 8, 8, pct});
+    }
+
+    std::printf("sweep,count,length,literal_pct,strategy,ns_per_op,bytes_per_op,allocs_per_op\n");
+    for (auto const& p : points)
+    {
+        for (auto const& s : strategies)
+        {
+            measure(p, s);
+        }
+    }
+    return 0 == sink;
+}
@@ -0,0 +1,83 @@
+// Writing many concatenated records to a file: operator S() into std::ofstream
+// against fsc_mmap_sink::append(). Writes to bench_mmap.out unless a path is
+// given.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "../fast_string_concatenator.hpp"
+#include "../fsc_mmap_sink.hpp"
+
+using namespace stlsoft;
+using string_class = std::string;
+
+namespace
+{
+    constexpr std::size_t records = 1000000;
+
+    template <class F>
+    double ms(F&& write_all)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        write_all();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    string_class read_file(char const* path)
+    {
+        std::ifstream is(path, std::ios::binary);
+        return string_class(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+
+    template <class F>
+    void for_each_record(F&& f)
+    {
+        string_class const name = "sensor";
+        string_class const unit = "kPa";
+        string_class id;
+        for (std::size_t i = 0; i < records; ++i)
+        {
+            id = std::to_string(i);
+            f(fsc_seed() + name + '-' + id + ',' + id + ".5 " + unit + '\n');
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    char const* const path = (argc > 1) ? argv[1] : "bench_mmap.out";
+
+    double const stream = ms([path]
+    {
+        std::ofstream os(path, std::ios::binary | std::ios::trunc);
+        for_each_record([&os](auto const& fsc)
+        {
+            string_class const s = fsc;
+            os.write(s.data(), static_cast<std::streamsize>(s.size()));
+        });
+    });
+
+    string_class const expected = read_file(path);
+
+    std::size_t written = 0;
+    double const mapped = ms([path, &written]
+    {
+        fsc_mmap_sink sink(path);
+        for_each_record([&sink](auto const& fsc) { sink.append(fsc); });
+        written = sink.size();
+    });
+
+    if (read_file(path) != expected)
+    {
+        std::printf("fsc_mmap_sink output differs from the ofstream output\n");
+        std::remove(path);
+        return 1;
+    }
+
+    std::printf("%zu records (%zu bytes) to %s\n", records, written, path);
+    std::printf("%-10s %10.1f ms\n%-10s %10.1f ms\n", "ofstream", stream, "mmap", mapped);
+    std::remove(path);
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Serial operator S() vs materialize_parallel() over growing concatenations.
+// The first size at which the parallel column wins is the crossover to use as
+// the threshold.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../fast_string_concatenator.hpp"
+#include "../fsc_parallel.hpp"
+#include "../fsc_thread_pool.hpp"
+
+using namespace stlsoft;
+using string_class = std::string;
+
+namespace
+{
+    constexpr std::size_t fragment_count = 32;
+
+    // Odd-length string, literal and character fragments, so that chunk boundaries fall inside fragments
+    bool verify(fsc_thread_pool& pool)
+    {
+        std::vector<string_class> fragments;
+        for (std::size_t i = 0; i < 40; ++i)
+        {
+            fragments.emplace_back(1 + (i * 7) % 37, static_cast<char>('A' + i % 26));
+        }
+
+        concat_arena<string_class> arena;
+        std::vector<concat_ptr_and_alloc<string_class>> chain;
+        chain.reserve(3 * fragments.size());
+        chain.push_back(fsc_safe_seed(arena) + fragments[0]);
+        for (std::size_t i = 1; i < fragments.size(); ++i)
+        {
+            chain.push_back(chain.back() + fragments[i]);
+            chain.push_back(chain.back() + "lit");
+            chain.push_back(chain.back() + static_cast<char>('0' + i % 10));
+        }
+
+        for (auto const& fsc : chain)
+        {
+            string_class const expected = fsc;
+
+            for (std::size_t parts = 1; parts <= 5; ++parts)
+            {
+                std::size_t const threshold = expected.size() / parts;
+
+                if (materialize_parallel(fsc, pool, threshold) != expected)
+                {
+                    std::printf("materialize_parallel() mismatch at %zu bytes, threshold %zu\n", expected.size(), threshold);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    template <class F>
+    double best_of(int runs, F&& f)
+    {
+        double best = 1e300;
+        for (int i = 0; i < runs; ++i)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            f();
+            std::chrono::duration<double, std::micro> const d = std::chrono::steady_clock::now() - start;
+            best = std::min(best, d.count());
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    fsc_thread_pool pool(std::max(4u, std::thread::hardware_concurrency()));
+    if (!verify(pool))
+    {
+        return 1;
+    }
+
+    std::printf("threads: %zu, fragments: %zu\n", pool.concurrency(), fragment_count);
+    std::printf("%12s %14s %14s %8s\n", "bytes", "serial us", "parallel us", "speedup");
+
+    for (std::size_t total = 4 * 1024; total <= 64 * 1024 * 1024; total *= 4)
+    {
+        std::vector<string_class> fragments;
+        for (std::size_t i = 0; i < fragment_count; ++i)
+        {
+            fragments.emplace_back(total / fragment_count, static_cast<char>('a' + i % 26));
+        }
+
+        concat_arena<string_class> arena;
+        std::vector<concat_ptr_and_alloc<string_class>> chain;
+        chain.reserve(fragment_count);
+        chain.push_back(fsc_safe_seed(arena) + fragments[0]);
+        for (std::size_t i = 1; i < fragment_count; ++i)
+        {
+            chain.push_back(chain.back() + fragments[i]);
+        }
+        auto const& fsc = chain.back();
+
+        if (materialize_parallel(fsc, pool, 0) != string_class(fsc))
+        {
+            std::printf("materialize_parallel() mismatch at %zu bytes\n", total);
+            return 1;
+        }
+
+        int const runs = total < 1024 * 1024 ? 200 : 10;
+        std::size_t sink = 0;
+        double const serial = best_of(runs, [&] { sink += string_class(fsc).size(); });
+        double const parallel = best_of(runs, [&] { sink += materialize_parallel(fsc, pool, 0).size(); });
+
+        std::printf("%12zu %14.1f %14.1f %8.2f\n", total, serial, parallel, serial / parallel);
+        if (sink == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
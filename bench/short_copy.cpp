@@ -0,0 +1,92 @@
+// Per-fragment copy cost of std::copy, std::memcpy and fsc_detail::copy_bytes()
+// over several fragment-size distributions.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "../fsc_copy.hpp"
+
+using namespace stlsoft;
+
+namespace
+{
+    constexpr std::size_t fragment_count = 1 << 16;
+
+    struct distribution
+    {
+        char const*     name;
+        std::size_t     (*next)(std::mt19937&);
+    };
+
+    distribution const distributions[] =
+    {
+            {"all 1 (separators)",  [](std::mt19937&) -> std::size_t { return 1; }}
+        ,   {"uniform 1-8",         [](std::mt19937& g) -> std::size_t { return 1 + g() % 8; }}
+        ,   {"uniform 1-16",        [](std::mt19937& g) -> std::size_t { return 1 + g() % 16; }}
+        ,   {"80% 1-4, 20% 5-32",   [](std::mt19937& g) -> std::size_t { return g() % 5 ? 1 + g() % 4 : 5 + g() % 28; }}
+        ,   {"uniform 1-64",        [](std::mt19937& g) -> std::size_t { return 1 + g() % 64; }}
+        ,   {"uniform 64-256",      [](std::mt19937& g) -> std::size_t { return 64 + g() % 193; }}
+    };
+
+    template <class F>
+    double ns_per_fragment(std::vector<std::size_t> const& lengths, std::vector<char> const& src, std::vector<char>& dst, F&& copy)
+    {
+        double best = 1e300;
+        for (int run = 0; run < 50; ++run)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            char const* s = src.data();
+            char* d = dst.data();
+            for (auto n : lengths)
+            {
+                d = copy(d, s, n);
+                s += n;
+            }
+            std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count() / static_cast<double>(lengths.size()));
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    std::printf("%-22s %12s %12s %12s\n", "fragment sizes", "std::copy", "memcpy", "copy_bytes");
+
+    for (auto const& dist : distributions)
+    {
+        std::mt19937 gen(42);
+        std::vector<std::size_t> lengths(fragment_count);
+        std::generate(lengths.begin(), lengths.end(), [&] { return dist.next(gen); });
+
+        std::size_t const total = std::accumulate(lengths.begin(), lengths.end(), std::size_t(0));
+        std::vector<char> src(total);
+        std::generate(src.begin(), src.end(), [&] { return static_cast<char>('a' + gen() % 26); });
+        std::vector<char> dst(total);
+
+        double const t_copy = ns_per_fragment(lengths, src, dst, [](char* d, char const* s, std::size_t n)
+        {
+            return std::copy(s, s + n, d);
+        });
+        double const t_memcpy = ns_per_fragment(lengths, src, dst, [](char* d, char const* s, std::size_t n)
+        {
+            return static_cast<char*>(std::memcpy(d, s, n)) + n;
+        });
+        double const t_kernel = ns_per_fragment(lengths, src, dst, [](char* d, char const* s, std::size_t n)
+        {
+            return fsc_detail::copy_bytes(d, s, n);
+        });
+
+        if (dst != src)
+        {
+            std::printf("copy mismatch\n");
+            return 1;
+        }
+        std::printf("%-22s %12.2f %12.2f %12.2f\n", dist.name, t_copy, t_memcpy, t_kernel);
+    }
+    return 0;
+}
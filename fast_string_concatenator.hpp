@@ -47,9 +47,13 @@
 
 #ifndef STLSOFT_INCL_STLSOFT_STRING_HPP_FAST_STRING_CONCATENATOR
 #define STLSOFT_INCL_STLSOFT_STRING_HPP_FAST_STRING_CONCATENATOR
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <memory>
+#include <stdexcept>
+#include <string_view>
+#include "fsc_copy.hpp"
 #include "short_alloc.h"
 
 namespace stlsoft
@@ -64,25 +68,51 @@ namespace stlsoft
     >
     using fast_string_concatenator_sptr = std::shared_ptr<fast_string_concatenator<S,C>>;
 
+    template<   class S
+            ,   class H
+    >
+    class fast_string_concatenator_slice;
+
+    /// Temporary strings up to this length are copied into the arena by the safe path; longer ones are moved there
+    ///
+    /// \note string_view operands are always copied, whatever their length, because the safe path cannot
+    ///   know what they view; one that does not fit in what is left of the arena is allocated with
+    ///   ::operator new. C string operands, e.g. literals, are referenced rather than copied.
+    constexpr const std::size_t fsc_capture_threshold = 64;
+
     template <class S, std::size_t N = 50>
     constexpr const std::size_t concat_alloc_size = sizeof(fast_string_concatenator<S,typename S::value_type>) * N;
 
-    template<class S>
-    using concat_allocator = short_alloc<fast_string_concatenator<S, typename S::value_type>, concat_alloc_size<S>>;
+    /// \param Size Arena capacity in bytes; a multiple of alignof(std::max_align_t)
+    template<class S, std::size_t Size = concat_alloc_size<S>>
+    using concat_allocator = short_alloc<fast_string_concatenator<S, typename S::value_type>, Size>;
 
-    template<typename S>
-    struct concat_arena : concat_allocator<S>::arena_type {};
+    /// \param Size Arena capacity in bytes, e.g. one measured by a profiling build (see fsc_arena_profile.hpp)
+    template<typename S, std::size_t Size = concat_alloc_size<S>>
+    struct concat_arena : concat_allocator<S, Size>::arena_type {};
 
     template<   class S
+            ,   std::size_t Size = concat_alloc_size<S>
     >
     struct concat_ptr_and_alloc
     {
         fast_string_concatenator_sptr<S> concat_ptr;
-        concat_allocator<S> alloc;
+        concat_allocator<S, Size> alloc;
         operator S() const
         {
             return concat_ptr->operator S();
         }
+        [[nodiscard]] std::size_t length() const
+        {
+            return concat_ptr->length();
+        }
+        /// Lazy view of [pos, pos + len) that shares ownership of the concatenation chain
+        [[nodiscard]] fast_string_concatenator_slice<S, fast_string_concatenator_sptr<S>> slice(std::size_t pos = 0, std::size_t len = S::npos) const;
+        template <class F>
+        void for_each_fragment(F&& f) const
+        {
+            concat_ptr->for_each_fragment(f);
+        }
     };
 } /* namespace stlsoft */
 
@@ -100,13 +130,13 @@ namespace stlsoft
         typedef S   string_type;
     };
 
-    template <template<class> class C, class T>
+    template <class S, std::size_t Size>
     class fsc_safe_seed
             : public fsc_seed
     {
-        C<T> & arena_;
+        concat_arena<S, Size> & arena_;
     public:
-        explicit fsc_safe_seed(C<T> & arena): arena_(arena) {}
+        explicit fsc_safe_seed(concat_arena<S, Size> & arena): arena_(arena) {}
         auto& get_arena() const
         {
             return arena_;
@@ -131,6 +161,7 @@ namespace stlsoft
         typedef fast_string_concatenator<S, C>      class_type;
         using sptr_class_type = fast_string_concatenator_sptr<S,C>;
         typedef std::size_t                         size_type;
+        typedef fast_string_concatenator_slice<S, class_type const*>    slice_type;
     private:
         typedef typename S::iterator      string_iterator_type;
 /// @}
@@ -151,6 +182,11 @@ namespace stlsoft
         fast_string_concatenator(sptr_class_type const& lhs, char_type /*const*/ rhs);
         fast_string_concatenator(fsc_seed const& lhs, string_type const& rhs);
         fast_string_concatenator(fsc_seed const& lhs, char rhs) : m_lhs(lhs), m_rhs(rhs){}
+        fast_string_concatenator(fsc_seed const& lhs, char_type const* rhs) : m_lhs(lhs), m_rhs(rhs){}
+
+        // These constructors are for operands the safe path has captured into its arena
+        fast_string_concatenator(fsc_seed const& lhs, std::basic_string_view<C> rhs) : m_lhs(lhs), m_rhs(rhs){}
+        fast_string_concatenator(sptr_class_type const& lhs, std::basic_string_view<C> rhs) : m_lhs(lhs), m_rhs(rhs){}
 
         // These constructors are for handling embedded braces in the concatenation sequences, and represent the pathological case
         fast_string_concatenator(class_type const& lhs, class_type const& rhs);
@@ -163,25 +199,59 @@ namespace stlsoft
 /// @{
     public:
         operator S() const;
+
+        [[nodiscard]] size_type length() const
+        {
+            return m_len;
+        }
+
+        /// Lazy view of [pos, pos + len); as with the concatenator itself, use it before the end of the expression
+        [[nodiscard]] slice_type slice(size_type pos = 0, size_type len = S::npos) const;
+
+        /// Calls f, left to right, with each fragment as an object with members <code>s</code> (pointer to
+        /// the characters) and <code>len</code>, letting callers snapshot a concatenation without materializing it
+        template <class F>
+        void for_each_fragment(F&& f) const
+        {
+            m_lhs.for_each_fragment(f);
+            m_rhs.for_each_fragment(f);
+        }
 /// @}
 
 /// \name Implementation
 /// @{
     private:
-        [[nodiscard]] size_type length() const
+        string_iterator_type write(string_iterator_type s) const
         {
-            return m_lhs.length() + m_rhs.length();
+            return m_rhs.write(m_lhs.write(s));
         }
 
-        string_iterator_type write(string_iterator_type s) const
+        // Writes len characters starting at pos; fragments lying wholly before pos are skipped by their length
+        string_iterator_type write(string_iterator_type s, size_type pos, size_type len) const
         {
-            return m_rhs.write(m_lhs.write(s));
+            size_type const lhs_len = m_lhs.length();
+
+            if (pos < lhs_len)
+            {
+                size_type const n = (len < lhs_len - pos) ? len : lhs_len - pos;
+
+                s = m_lhs.write(s, pos, n);
+                len -= n;
+                pos = 0;
+            }
+            else
+            {
+                pos -= lhs_len;
+            }
+
+            return (0 != len) ? m_rhs.write(s, pos, len) : s;
         }
 
     private:
         struct Data;
 
         friend struct Data;
+        template <class S1, class H1> friend class fast_string_concatenator_slice;
 
         struct Data
         {
@@ -217,6 +287,12 @@ namespace stlsoft
                 ref.u.cstring.len = str.length();
                 ref.u.cstring.s   = str.data();
             }
+            explicit Data(std::basic_string_view<char_type> s)
+                    : type(cstring)
+            {
+                ref.u.cstring.len = s.size();
+                ref.u.cstring.s   = s.data();
+            }
             explicit Data(char_type const* s)
                     : type(cstring)
             {
@@ -296,8 +372,7 @@ namespace stlsoft
                         break;
                     case    cstring:
                         len = ref.u.cstring.len;
-                        std::copy(&ref.u.cstring.s[0], &ref.u.cstring.s[0] + len, s);
-                        s += len;
+                        s = fsc_detail::copy_fragment(s, ref.u.cstring.s, len);
                         break;
                     case    concat:
                         s = ref.u.concat->write(s);
@@ -310,6 +385,59 @@ namespace stlsoft
                 return s;
             }
 
+            [[nodiscard]] auto write(string_iterator_type s, size_type pos, size_type len) const
+            {
+                assert(type == cstring || type == single || type == concat || type == seed || type == concat_ptr);
+                assert(pos + len <= length());
+
+                switch(type)
+                {
+                    case    seed:
+                        break;
+                    case    single:
+                        *(s++) = ref.u.ch;
+                        break;
+                    case    cstring:
+                        // Clamped to the fragment, which a valid slice never exceeds, so the copied length is bounded
+                        len = (pos < ref.u.cstring.len) ? std::min(len, ref.u.cstring.len - pos) : 0;
+                        s = fsc_detail::copy_fragment(s, ref.u.cstring.s + pos, len);
+                        break;
+                    case    concat:
+                        s = ref.u.concat->write(s, pos, len);
+                        break;
+                    case    concat_ptr:
+                        s = ref.concat_ptr->write(s, pos, len);
+                        break;
+                }
+
+                return s;
+            }
+
+            // Visits the leaf fragments, left to right, as CStrings
+            template <class F>
+            void for_each_fragment(F&& f) const
+            {
+                assert(type == cstring || type == single || type == concat || type == seed || type == concat_ptr);
+
+                switch(type)
+                {
+                    case    seed:
+                        break;
+                    case    single:
+                        f(CString{1, &ref.u.ch});
+                        break;
+                    case    cstring:
+                        f(ref.u.cstring);
+                        break;
+                    case    concat:
+                        ref.u.concat->for_each_fragment(f);
+                        break;
+                    case    concat_ptr:
+                        ref.concat_ptr->for_each_fragment(f);
+                        break;
+                }
+            }
+
             DataRef         ref;
             DataType const  type;
         };
@@ -319,6 +447,8 @@ namespace stlsoft
     private:
         Data    m_lhs;
         Data    m_rhs;
+        // Cached so that nested length() calls, and hence slicing, do not walk the whole chain
+        size_type const m_len = m_lhs.length() + m_rhs.length();
 /// @}
 
 // Not to be implemented
@@ -472,6 +602,178 @@ namespace stlsoft
         return s;
     }
 
+/* /////////////////////////////////////////////////////////////////////////
+ * slicing
+ */
+
+/** Lazy substring of a concatenation, materialized by copying only the requested characters
+ *
+ * \param H Either a raw pointer (stack path) or a shared pointer (safe path) to the concatenator
+ */
+    template<   class S
+            ,   class H
+    >
+    class fast_string_concatenator_slice
+    {
+    public:
+        typedef S                                   string_type;
+        typedef std::size_t                         size_type;
+        typedef fast_string_concatenator_slice<S, H>    class_type;
+
+    public:
+        fast_string_concatenator_slice(H concat, size_type pos, size_type len)
+                : m_concat(std::move(concat))
+                , m_pos(pos)
+        {
+            size_type const total = m_concat->length();
+
+            if (pos > total)
+            {
+                throw std::out_of_range("fast_string_concatenator_slice: pos is out of range");
+            }
+            m_len = (len < total - pos) ? len : total - pos;
+        }
+
+        [[nodiscard]] size_type length() const
+        {
+            return m_len;
+        }
+
+        [[nodiscard]] class_type slice(size_type pos = 0, size_type len = S::npos) const
+        {
+            if (pos > m_len)
+            {
+                throw std::out_of_range("fast_string_concatenator_slice: pos is out of range");
+            }
+            return class_type(m_concat, m_pos + pos, (len < m_len - pos) ? len : m_len - pos);
+        }
+
+        operator S() const
+        {
+            string_type s(m_len, '~');
+            if (0 != m_len)
+            {
+                m_concat->write(s.begin(), m_pos, m_len);
+            }
+            assert(s.length() == strlen(s.c_str()));
+
+            return s;
+        }
+
+    private:
+        H           m_concat;
+        size_type   m_pos;
+        size_type   m_len;
+    };
+
+    template<   class S
+            ,   class C
+    >
+    inline typename fast_string_concatenator<S, C>::slice_type fast_string_concatenator<S, C>::slice(size_type pos, size_type len) const
+    {
+        return slice_type(this, pos, len);
+    }
+
+    template<   class S
+            ,   std::size_t Size
+    >
+    inline fast_string_concatenator_slice<S, fast_string_concatenator_sptr<S>> concat_ptr_and_alloc<S, Size>::slice(std::size_t pos, std::size_t len) const
+    {
+        return fast_string_concatenator_slice<S, fast_string_concatenator_sptr<S>>(concat_ptr, pos, len);
+    }
+
+/* /////////////////////////////////////////////////////////////////////////
+ * captured operands
+ */
+
+/** Safe-path node whose right operand is a copy, held in the arena, of a short temporary or a view
+ *
+ * Allocated with the arena allocator; the chain refers to the embedded node through an aliasing shared pointer
+ */
+    template<   class S
+            ,   std::size_t Size
+    >
+    class concat_copied_operand
+    {
+    public:
+        typedef typename S::value_type                                                          char_type;
+        typedef typename std::allocator_traits<concat_allocator<S, Size>>::template rebind_alloc<char_type>   char_allocator_type;
+
+    public:
+        template <class L>
+        concat_copied_operand(concat_allocator<S, Size> const& al, L const& lhs, std::basic_string_view<char_type> rhs)
+                : m_alloc(al)
+                , m_len(rhs.size())
+                , m_chars(m_alloc.allocate(m_len))
+                , m_node(lhs, std::basic_string_view<char_type>(m_chars, m_len))
+        {
+            fsc_detail::copy_fragment(m_chars, rhs.data(), m_len);
+        }
+        ~concat_copied_operand()
+        {
+            m_alloc.deallocate(m_chars, m_len);
+        }
+        concat_copied_operand(concat_copied_operand const&) = delete;
+        concat_copied_operand& operator =(concat_copied_operand const&) = delete;
+
+        fast_string_concatenator<S>& node() noexcept {return m_node;}
+
+    private:
+        char_allocator_type             m_alloc;
+        std::size_t const               m_len;
+        char_type* const                m_chars;
+        fast_string_concatenator<S>     m_node;
+    };
+
+/** Safe-path node that owns, in the arena, a long temporary string moved into it
+ */
+    template<   class S
+    >
+    class concat_moved_operand
+    {
+    public:
+        template <class L>
+        concat_moved_operand(L const& lhs, S&& rhs)
+                : m_owner(std::move(rhs))
+                , m_node(lhs, m_owner)
+        {}
+        concat_moved_operand(concat_moved_operand const&) = delete;
+        concat_moved_operand& operator =(concat_moved_operand const&) = delete;
+
+        fast_string_concatenator<S>& node() noexcept {return m_node;}
+
+    private:
+        S const                         m_owner;
+        fast_string_concatenator<S>     m_node;
+    };
+
+namespace fsc_detail
+{
+    template<   class S
+            ,   std::size_t Size
+            ,   class L
+    >
+    inline concat_ptr_and_alloc<S, Size> capture(concat_allocator<S, Size> const& al, L const& lhs, std::basic_string_view<typename S::value_type> rhs)
+    {
+        auto const owner = std::allocate_shared<concat_copied_operand<S, Size>>(al, al, lhs, rhs);
+        return concat_ptr_and_alloc<S, Size> {fast_string_concatenator_sptr<S>(owner, &owner->node()), al};
+    }
+
+    template<   class S
+            ,   std::size_t Size
+            ,   class L
+    >
+    inline concat_ptr_and_alloc<S, Size> capture(concat_allocator<S, Size> const& al, L const& lhs, S&& rhs)
+    {
+        if (rhs.length() <= fsc_capture_threshold)
+        {
+            return capture(al, lhs, std::basic_string_view<typename S::value_type>(rhs));
+        }
+        auto const owner = std::allocate_shared<concat_moved_operand<S>>(al, lhs, std::move(rhs));
+        return concat_ptr_and_alloc<S, Size> {fast_string_concatenator_sptr<S>(owner, &owner->node()), al};
+    }
+} /* namespace fsc_detail */
+
 /* /////////////////////////////////////////////////////////////////////////
  * operator +
  */
@@ -490,15 +792,50 @@ namespace stlsoft
         return fast_string_concatenator<S>(lhs, rhs);
     }
 
-    template<class S, template <class> class T>
-    concat_ptr_and_alloc<S> operator +(fsc_safe_seed<T,S> const& lhs, S const& rhs)
+    template<class S, std::size_t Size>
+    concat_ptr_and_alloc<S, Size> operator +(fsc_safe_seed<S, Size> const& lhs, S const& rhs)
 
     {
-        concat_allocator<S> al(lhs.get_arena());
-        concat_ptr_and_alloc<S> ret {std::allocate_shared<fast_string_concatenator<S>>(al, lhs, rhs), al};
+        concat_allocator<S, Size> al(lhs.get_arena());
+        concat_ptr_and_alloc<S, Size> ret {std::allocate_shared<fast_string_concatenator<S>>(al, lhs, rhs), al};
         return ret;
     }
 
+    template<   class S
+            ,   std::size_t Size
+            ,   class C
+    >
+    inline concat_ptr_and_alloc<S, Size> operator +(fsc_safe_seed<S, Size> const& lhs, C const* rhs)
+    {
+        concat_allocator<S, Size> al(lhs.get_arena());
+        return concat_ptr_and_alloc<S, Size> {std::allocate_shared<fast_string_concatenator<S>>(al, lhs, rhs), al};
+    }
+
+// These operators capture temporaries and views into the arena, so that they outlive the expression
+    template<class S, std::size_t Size>
+    concat_ptr_and_alloc<S, Size> operator +(fsc_safe_seed<S, Size> const& lhs, S&& rhs)
+    {
+        return fsc_detail::capture(concat_allocator<S, Size>(lhs.get_arena()), lhs, std::move(rhs));
+    }
+
+    template<class S, std::size_t Size>
+    concat_ptr_and_alloc<S, Size> operator +(fsc_safe_seed<S, Size> const& lhs, std::basic_string_view<typename S::value_type> rhs)
+    {
+        return fsc_detail::capture(concat_allocator<S, Size>(lhs.get_arena()), lhs, rhs);
+    }
+
+    template<class S, std::size_t Size>
+    concat_ptr_and_alloc<S, Size> operator +(concat_ptr_and_alloc<S, Size> const& lhs, S&& rhs)
+    {
+        return fsc_detail::capture(lhs.alloc, lhs.concat_ptr, std::move(rhs));
+    }
+
+    template<class S, std::size_t Size>
+    concat_ptr_and_alloc<S, Size> operator +(concat_ptr_and_alloc<S, Size> const& lhs, std::basic_string_view<typename S::value_type> rhs)
+    {
+        return fsc_detail::capture(lhs.alloc, lhs.concat_ptr, rhs);
+    }
+
     template<   class S
             ,   class C
     >
@@ -516,10 +853,11 @@ namespace stlsoft
     }
 
     template<   class S
+            ,   std::size_t Size
     >
-    inline auto operator +(concat_ptr_and_alloc<S> const & lhs, S const& rhs)
+    inline auto operator +(concat_ptr_and_alloc<S, Size> const & lhs, S const& rhs)
     {
-        return concat_ptr_and_alloc<S> {std::allocate_shared<fast_string_concatenator<S>>(lhs.alloc, lhs.concat_ptr, rhs)
+        return concat_ptr_and_alloc<S, Size> {std::allocate_shared<fast_string_concatenator<S>>(lhs.alloc, lhs.concat_ptr, rhs)
                 , std::move(lhs.alloc)};
     }
 
@@ -531,11 +869,12 @@ namespace stlsoft
         return fast_string_concatenator<S, C>(lhs, rhs);
     }
     template<   class S
+            ,   std::size_t Size
             ,   class C
     >
-    inline auto operator +(concat_ptr_and_alloc<S> const & lhs, C const* rhs)
+    inline auto operator +(concat_ptr_and_alloc<S, Size> const & lhs, C const* rhs)
     {
-        return concat_ptr_and_alloc<S> {std::allocate_shared<fast_string_concatenator<S>>(lhs.alloc, lhs.concat_ptr, rhs)
+        return concat_ptr_and_alloc<S, Size> {std::allocate_shared<fast_string_concatenator<S>>(lhs.alloc, lhs.concat_ptr, rhs)
                 , std::move(lhs.alloc)};
     }
 
@@ -548,11 +887,12 @@ namespace stlsoft
     }
 
     template<   class S
+            ,   std::size_t Size
             ,   class C
     >
-    inline auto operator +(concat_ptr_and_alloc<S> const & lhs, C const rhs)
+    inline auto operator +(concat_ptr_and_alloc<S, Size> const & lhs, C const rhs)
     {
-        return concat_ptr_and_alloc<S> {std::allocate_shared<fast_string_concatenator<S>>(lhs.alloc, lhs.concat_ptr, rhs)
+        return concat_ptr_and_alloc<S, Size> {std::allocate_shared<fast_string_concatenator<S>>(lhs.alloc, lhs.concat_ptr, rhs)
                 , std::move(lhs.alloc)};
     }
 
@@ -0,0 +1,178 @@
+#ifndef FSC_ARENA_PROFILE_HPP
+#define FSC_ARENA_PROFILE_HPP
+
+// Per-call-site concat_arena sizing.
+//
+// Declare the arena of a call site with
+//
+//     FSC_SITE_ARENA(string_class, "request_log", arena);
+//
+// Normally the arena is given the size recorded for "request_log" in the
+// generated fsc_arena_sizes.h, if that header is on the include path, and
+// concat_alloc_size<S> otherwise. In a profiling build (FSC_ARENA_PROFILE
+// defined in every translation unit) each site instead gets a heap-held arena
+// of fsc_arena_profile_size bytes, so profiling does not grow the stack frame,
+// and its peak arena usage is recorded;
+// fsc_arena_profile::write_header() then emits fsc_arena_sizes.h, which is
+// also written at exit to the path in the FSC_ARENA_PROFILE_OUT environment
+// variable, if set. Sites not exercised by the profiling run keep the
+// default size.
+
+#include <cstddef>
+#include "fast_string_concatenator.hpp"
+
+#if defined(FSC_ARENA_PROFILE)
+# include <algorithm>
+# include <cstdlib>
+# include <fstream>
+# include <map>
+# include <memory>
+# include <mutex>
+# include <ostream>
+# include <string>
+#endif
+
+namespace stlsoft
+{
+namespace fsc_detail
+{
+    struct arena_site_size
+    {
+        char const*     site;
+        std::size_t     size;
+    };
+
+    constexpr arena_site_size arena_site_sizes[] =
+    {
+#if !defined(FSC_ARENA_PROFILE) && __has_include("fsc_arena_sizes.h")
+# define FSC_ARENA_SITE_SIZE(site, size)    {site, size},
+# include "fsc_arena_sizes.h"
+# undef FSC_ARENA_SITE_SIZE
+#endif
+            {nullptr, 0}
+    };
+
+    constexpr bool same_site(char const* lhs, char const* rhs)
+    {
+        for (; *lhs == *rhs; ++lhs, ++rhs)
+        {
+            if ('\0' == *lhs)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+} /* namespace fsc_detail */
+
+    /// Arena size, in bytes, for the named call site
+    template <class S>
+    constexpr std::size_t concat_arena_size(char const* site)
+    {
+        for (auto const& entry : fsc_detail::arena_site_sizes)
+        {
+            if (nullptr != entry.site && fsc_detail::same_site(entry.site, site))
+            {
+                return entry.size;
+            }
+        }
+        return concat_alloc_size<S>;
+    }
+
+#if defined(FSC_ARENA_PROFILE)
+
+    /// Arena size given to every call site while profiling; big enough not to clip what is measured
+    constexpr std::size_t fsc_arena_profile_size = 64 * 1024;
+
+    class fsc_arena_profile
+    {
+    public:
+        static void record(char const* site, std::size_t peak)
+        {
+            auto& r = registry();
+            std::lock_guard<std::mutex> lock(r.mx);
+            auto& size = r.peaks[site];
+            size = std::max(size, peak);
+        }
+
+        /// Writes the recorded peaks as fsc_arena_sizes.h
+        static void write_header(std::ostream& os)
+        {
+            auto& r = registry();
+            std::lock_guard<std::mutex> lock(r.mx);
+            r.write(os);
+        }
+
+    private:
+        struct registry_type
+        {
+            std::mutex                          mx;
+            std::map<std::string, std::size_t>  peaks;
+
+            ~registry_type()
+            {
+                if (char const* path = std::getenv("FSC_ARENA_PROFILE_OUT"))
+                {
+                    std::ofstream os(path);
+                    write(os);
+                }
+            }
+
+            void write(std::ostream& os) const
+            {
+                constexpr std::size_t align = alignof(std::max_align_t);
+
+                os << "// Generated by an FSC_ARENA_PROFILE build: peak concat_arena bytes per call site\n";
+                for (auto const& p : peaks)
+                {
+                    std::size_t const size = std::max(align, (p.second + align - 1) & ~(align - 1));
+                    os << "FSC_ARENA_SITE_SIZE(\"" << p.first << "\", " << size << ")\n";
+                }
+            }
+        };
+
+        static registry_type& registry()
+        {
+            static registry_type r;
+            return r;
+        }
+    };
+
+    /// Records the peak usage of a site's arena when the scope holding it ends
+    template <class A>
+    class fsc_arena_probe
+    {
+    public:
+        fsc_arena_probe(A const& arena, char const* site) noexcept
+                : arena_(arena)
+                , site_(site)
+        {}
+        ~fsc_arena_probe()
+        {
+            fsc_arena_profile::record(site_, arena_.peak());
+        }
+        fsc_arena_probe(const fsc_arena_probe&) = delete;
+        fsc_arena_probe& operator=(const fsc_arena_probe&) = delete;
+
+    private:
+        A const&        arena_;
+        char const*     site_;
+    };
+
+# define FSC_SITE_ARENA(S, site, name)                                                          \
+    auto const name##_fsc_arena =                                                              \
+        ::std::make_unique<::stlsoft::concat_arena<S, ::stlsoft::fsc_arena_profile_size>>();   \
+    auto& name = *name##_fsc_arena;                                                            \
+    ::stlsoft::fsc_arena_probe<::stlsoft::concat_arena<S, ::stlsoft::fsc_arena_profile_size>>  \
+        name##_fsc_probe(name, site)
+
+#else
+
+# define FSC_SITE_ARENA(S, site, name)                                                          \
+    ::stlsoft::concat_arena<S, ::stlsoft::concat_arena_size<S>(site)> name
+
+#endif
+
+} /* namespace stlsoft */
+
+#endif  // FSC_ARENA_PROFILE_HPP
@@ -0,0 +1,197 @@
+#ifndef FSC_ASYNC_SINK_HPP
+#define FSC_ASYNC_SINK_HPP
+
+// Asynchronous sink for logging concatenations to a file descriptor.
+//
+// The producer only snapshots the fragments of a concatenation into a
+// preallocated single-producer/single-consumer ring buffer, reserving
+// length() bytes at once; a background thread drains the buffer to the
+// descriptor in batches. POSIX only.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "fsc_copy.hpp"
+
+namespace stlsoft
+{
+    class fsc_async_sink
+    {
+    public:
+        /// \param fd Descriptor to write to; it is not closed by the sink
+        /// \param capacity Ring buffer size in bytes, rounded up to a power of two
+        /// \param idle How long the draining thread sleeps when the buffer is empty
+        explicit fsc_async_sink(int fd, std::size_t capacity = 1 << 20, std::chrono::microseconds idle = std::chrono::microseconds(200))
+                : fd_(fd)
+                , capacity_(round_up(capacity))
+                , mask_(capacity_ - 1)
+                , buf_(new char[capacity_])
+                , idle_(idle)
+                , drainer_([this] { drain(); })
+        {}
+        ~fsc_async_sink()
+        {
+            stop_.store(true, std::memory_order_release);
+            drainer_.join();
+        }
+        fsc_async_sink(const fsc_async_sink&) = delete;
+        fsc_async_sink& operator=(const fsc_async_sink&) = delete;
+
+        /// Snapshots a concatenation (stack or safe) into the buffer; only one thread may push
+        ///
+        /// \return false if the buffer has no room for the whole record right now; the caller may retry
+        ///   or drop it, and full() counts how often this happened
+        /// \throws std::length_error if the record is longer than capacity() and so can never fit
+        template <class T>
+        bool push(T const& fsc)
+        {
+            std::size_t const n     = fsc.length();
+
+            if (n > capacity_)
+            {
+                throw std::length_error("fsc_async_sink: record is longer than the buffer capacity");
+            }
+
+            std::size_t const head  = head_.load(std::memory_order_relaxed);
+            std::size_t const tail  = tail_.load(std::memory_order_acquire);
+
+            if (n > capacity_ - (head - tail))
+            {
+                full_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            std::size_t pos = head;
+            auto copy = [this, &pos](auto const& fragment)
+            {
+                char const* s   = fragment.s;
+                std::size_t len = fragment.len;
+
+                while (0 != len)
+                {
+                    std::size_t const at    = pos & mask_;
+                    std::size_t const chunk = std::min(len, capacity_ - at);
+
+                    fsc_detail::copy_bytes(buf_.get() + at, s, chunk);
+                    pos += chunk;
+                    s   += chunk;
+                    len -= chunk;
+                }
+            };
+            fsc.for_each_fragment(copy);
+            assert(pos == head + n);
+
+            head_.store(head + n, std::memory_order_release);
+            return true;
+        }
+
+        /// Waits until everything pushed so far has been handed to the descriptor
+        void flush() const
+        {
+            std::size_t const head = head_.load(std::memory_order_relaxed);
+            while (tail_.load(std::memory_order_acquire) != head)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        /// Number of push() calls that returned false because the buffer was full
+        [[nodiscard]] std::size_t full() const noexcept {return full_.load(std::memory_order_relaxed);}
+        [[nodiscard]] std::size_t write_errors() const noexcept {return write_errors_.load(std::memory_order_relaxed);}
+        [[nodiscard]] std::size_t capacity() const noexcept {return capacity_;}
+
+    private:
+        static std::size_t round_up(std::size_t n) noexcept
+        {
+            std::size_t r = 64;
+            while (r < n)
+            {
+                r <<= 1;
+            }
+            return r;
+        }
+
+        void drain()
+        {
+            for (;;)
+            {
+                // Read stop_ first so that nothing pushed before it was set is left behind
+                bool const stopping     = stop_.load(std::memory_order_acquire);
+                std::size_t const head  = head_.load(std::memory_order_acquire);
+                std::size_t const tail  = tail_.load(std::memory_order_relaxed);
+
+                if (head == tail)
+                {
+                    if (stopping)
+                    {
+                        return;
+                    }
+                    std::this_thread::sleep_for(idle_);
+                    continue;
+                }
+
+                // Everything available goes out in one writev(), in two pieces if it wraps
+                std::size_t const at    = tail & mask_;
+                std::size_t const first = std::min(head - tail, capacity_ - at);
+                iovec iov[2] = {{buf_.get() + at, first}, {buf_.get(), head - tail - first}};
+
+                write_all(iov, (0 != iov[1].iov_len) ? 2 : 1);
+                tail_.store(head, std::memory_order_release);
+            }
+        }
+
+        void write_all(iovec* iov, int count) noexcept
+        {
+            while (0 != count)
+            {
+                ssize_t const r = ::writev(fd_, iov, count);
+
+                if (r < 0)
+                {
+                    if (EINTR == errno)
+                    {
+                        continue;
+                    }
+                    write_errors_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                for (std::size_t done = static_cast<std::size_t>(r); 0 != count; )
+                {
+                    if (done < iov->iov_len)
+                    {
+                        iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+                        iov->iov_len -= done;
+                        break;
+                    }
+                    done -= iov->iov_len;
+                    ++iov;
+                    --count;
+                }
+            }
+        }
+
+        int const                       fd_;
+        std::size_t const               capacity_;
+        std::size_t const               mask_;
+        std::unique_ptr<char[]> const   buf_;
+        std::chrono::microseconds const idle_;
+
+        alignas(64) std::atomic<std::size_t>    head_{0};
+        alignas(64) std::atomic<std::size_t>    tail_{0};
+        alignas(64) std::atomic<bool>           stop_{false};
+        std::atomic<std::size_t>                full_{0};
+        std::atomic<std::size_t>                write_errors_{0};
+
+        std::thread                     drainer_;
+    };
+} /* namespace stlsoft */
+
+#endif  // FSC_ASYNC_SINK_HPP
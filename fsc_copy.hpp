@@ -0,0 +1,129 @@
+#ifndef FSC_COPY_HPP
+#define FSC_COPY_HPP
+
+// Copy kernel for the short fragments (separators, single words, short ids)
+// that dominate typical concatenations. Every length up to 64 bytes is copied
+// with two possibly overlapping fixed-width loads and stores instead of a
+// byte loop or a library call: scalar for up to 16 bytes, SSE2 (baseline on
+// x86-64) up to 32 and AVX2, when the CPU has it, up to 64.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+# define FSC_COPY_X86_64
+# include <immintrin.h>
+# if !defined(__AVX2__) && (defined(__GNUC__) || defined(__clang__))
+#  define FSC_COPY_AVX2_DISPATCH
+# endif
+#endif
+
+namespace stlsoft
+{
+namespace fsc_detail
+{
+    template <class T>
+    inline void copy_two(char* d, char const* s, std::size_t n) noexcept
+    {
+        T head, tail;
+        std::memcpy(&head, s, sizeof(T));
+        std::memcpy(&tail, s + n - sizeof(T), sizeof(T));
+        std::memcpy(d, &head, sizeof(T));
+        std::memcpy(d + n - sizeof(T), &tail, sizeof(T));
+    }
+
+#if defined(FSC_COPY_AVX2_DISPATCH)
+    __attribute__((target("avx2")))
+    inline void copy_33_64_avx2(char* d, char const* s, std::size_t n) noexcept
+    {
+        __m256i const head = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s));
+        __m256i const tail = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s + n - 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), head);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + n - 32), tail);
+    }
+
+    inline bool const has_avx2 = []
+    {
+        __builtin_cpu_init();
+        return 0 != __builtin_cpu_supports("avx2");
+    }();
+#endif
+
+    /// Copies n bytes from s to the non-overlapping d, returning d + n
+    inline char* copy_bytes(char* d, char const* s, std::size_t n) noexcept
+    {
+        if (n <= 16)
+        {
+            if (n >= 8)
+            {
+                copy_two<std::uint64_t>(d, s, n);
+            }
+            else if (n >= 4)
+            {
+                copy_two<std::uint32_t>(d, s, n);
+            }
+            else if (n >= 2)
+            {
+                copy_two<std::uint16_t>(d, s, n);
+            }
+            else if (0 != n)
+            {
+                *d = *s;
+            }
+            return d + n;
+        }
+#if defined(FSC_COPY_X86_64)
+        if (n <= 32)
+        {
+            __m128i const head = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s));
+            __m128i const tail = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s + n - 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d), head);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + n - 16), tail);
+            return d + n;
+        }
+# if defined(__AVX2__)
+        if (n <= 64)
+        {
+            __m256i const head = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s));
+            __m256i const tail = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s + n - 32));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), head);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + n - 32), tail);
+            return d + n;
+        }
+# elif defined(FSC_COPY_AVX2_DISPATCH)
+        if (n <= 64 && has_avx2)
+        {
+            copy_33_64_avx2(d, s, n);
+            return d + n;
+        }
+# endif
+#endif
+        std::memcpy(d, s, n);
+        return d + n;
+    }
+
+    /// Copies [s, s + n) to the contiguous output iterator d, using copy_bytes() for byte-sized characters
+    template <class I, class C>
+    inline I copy_fragment(I d, C const* s, std::size_t n) noexcept
+    {
+        if constexpr (sizeof(C) == 1 && std::is_trivially_copyable_v<C>)
+        {
+            if (0 != n)
+            {
+                copy_bytes(reinterpret_cast<char*>(std::addressof(*d)), reinterpret_cast<char const*>(s), n);
+            }
+            return d + n;
+        }
+        else
+        {
+            return std::copy(s, s + n, d);
+        }
+    }
+} /* namespace fsc_detail */
+} /* namespace stlsoft */
+
+#endif  // FSC_COPY_HPP
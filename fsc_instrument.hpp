@@ -0,0 +1,298 @@
+#ifndef FSC_INSTRUMENT_HPP
+#define FSC_INSTRUMENT_HPP
+
+// Allocation and arena instrumentation for tests and benchmarks.
+//
+// Define FSC_INSTRUMENT (consistently, in every translation unit, so from the
+// build system rather than a header; see SAMPLE_WITH_INSTRUMENTATION) to enable
+// the per-thread counters; otherwise every hook expands to nothing and
+// counters() always reads zero. Heap counters additionally need the global
+// operator new/delete replacements, emitted by defining
+// FSC_INSTRUMENT_REPLACE_NEW before including this header in exactly one
+// translation unit of the program; that covers the plain and the aligned
+// (std::align_val_t) forms, single and array, throwing and nothrow.
+//
+// Counters belong to the thread that allocated or freed, so a block allocated
+// on one thread and freed on another (e.g. a task handed to a thread pool) is
+// counted as an allocation on the first thread and a deallocation on the
+// second.
+
+#include <cstddef>
+
+#if defined(FSC_INSTRUMENT)
+# define FSC_INSTRUMENT_HOOK(call)  ::fsc_instrument::call
+#else
+# define FSC_INSTRUMENT_HOOK(call)  static_cast<void>(0)
+#endif
+
+namespace fsc_instrument
+{
+    struct counters
+    {
+        std::size_t allocations             = 0;    ///< operator new calls
+        std::size_t deallocations           = 0;    ///< operator delete calls with a non-null pointer
+        std::size_t bytes_allocated         = 0;
+        std::size_t bytes_freed             = 0;
+        std::size_t arena_bump_hits         = 0;    ///< arena allocations served from the buffer
+        std::size_t arena_reclaims          = 0;    ///< arena deallocations that moved the top back
+        std::size_t arena_heap_fallbacks    = 0;    ///< arena allocations that did not fit and went to the heap
+        std::size_t arena_high_water        = 0;    ///< largest arena::used() seen
+
+        // Negative on a thread that freed more than it allocated, as happens with cross-thread frees
+        [[nodiscard]] std::ptrdiff_t live_allocations() const noexcept {return static_cast<std::ptrdiff_t>(allocations - deallocations);}
+        [[nodiscard]] std::ptrdiff_t live_bytes() const noexcept {return static_cast<std::ptrdiff_t>(bytes_allocated - bytes_freed);}
+    };
+
+#if defined(FSC_INSTRUMENT)
+    inline thread_local counters tls_counters;
+
+    inline void on_heap_alloc(std::size_t n) noexcept
+    {
+        ++tls_counters.allocations;
+        tls_counters.bytes_allocated += n;
+    }
+    inline void on_heap_free(std::size_t n) noexcept
+    {
+        ++tls_counters.deallocations;
+        tls_counters.bytes_freed += n;
+    }
+    inline void on_arena_bump(std::size_t used) noexcept
+    {
+        ++tls_counters.arena_bump_hits;
+        if (used > tls_counters.arena_high_water)
+        {
+            tls_counters.arena_high_water = used;
+        }
+    }
+    inline void on_arena_reclaim() noexcept
+    {
+        ++tls_counters.arena_reclaims;
+    }
+    inline void on_arena_heap_fallback() noexcept
+    {
+        ++tls_counters.arena_heap_fallbacks;
+    }
+#endif
+
+    /// Counters of the calling thread since it started
+    inline counters current() noexcept
+    {
+#if defined(FSC_INSTRUMENT)
+        return tls_counters;
+#else
+        return counters();
+#endif
+    }
+
+    /// Measures what the calling thread does between construction and delta()
+    class scope
+    {
+    public:
+        scope() noexcept
+                : start_(current())
+        {
+#if defined(FSC_INSTRUMENT)
+            tls_counters.arena_high_water = 0;
+#endif
+        }
+        ~scope()
+        {
+#if defined(FSC_INSTRUMENT)
+            if (start_.arena_high_water > tls_counters.arena_high_water)
+            {
+                tls_counters.arena_high_water = start_.arena_high_water;
+            }
+#endif
+        }
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+        /// Counts since construction; arena_high_water is the peak reached inside the scope
+        [[nodiscard]] counters delta() const noexcept
+        {
+            counters const now = current();
+            counters d;
+            d.allocations           = now.allocations - start_.allocations;
+            d.deallocations         = now.deallocations - start_.deallocations;
+            d.bytes_allocated       = now.bytes_allocated - start_.bytes_allocated;
+            d.bytes_freed           = now.bytes_freed - start_.bytes_freed;
+            d.arena_bump_hits       = now.arena_bump_hits - start_.arena_bump_hits;
+            d.arena_reclaims        = now.arena_reclaims - start_.arena_reclaims;
+            d.arena_heap_fallbacks  = now.arena_heap_fallbacks - start_.arena_heap_fallbacks;
+            d.arena_high_water      = now.arena_high_water;
+            return d;
+        }
+
+    private:
+        counters const start_;
+    };
+} /* namespace fsc_instrument */
+
+#endif  // FSC_INSTRUMENT_HPP
+
+#if defined(FSC_INSTRUMENT) && defined(FSC_INSTRUMENT_REPLACE_NEW) && !defined(FSC_INSTRUMENT_NEW_REPLACED)
+#define FSC_INSTRUMENT_NEW_REPLACED
+
+#include <cstdlib>
+#include <new>
+
+// Each block carries its size in front so that unsized delete can subtract the right number of bytes
+namespace fsc_instrument
+{
+    constexpr std::size_t block_header = alignof(std::max_align_t);
+}
+
+void* operator new(std::size_t n)
+{
+    void* const p = std::malloc(fsc_instrument::block_header + n);
+    if (nullptr == p)
+    {
+        throw std::bad_alloc();
+    }
+    *static_cast<std::size_t*>(p) = n;
+    fsc_instrument::on_heap_alloc(n);
+    return static_cast<char*>(p) + fsc_instrument::block_header;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (nullptr != p)
+    {
+        void* const block = static_cast<char*>(p) - fsc_instrument::block_header;
+        fsc_instrument::on_heap_free(*static_cast<std::size_t*>(block));
+        std::free(block);
+    }
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+// Over-aligned blocks put the size just below the returned pointer, which sits one alignment past the start
+namespace fsc_instrument
+{
+    inline std::size_t aligned_offset(std::align_val_t al) noexcept
+    {
+        auto const a = static_cast<std::size_t>(al);
+        return a < block_header ? block_header : a;
+    }
+}
+
+void* operator new(std::size_t n, std::align_val_t al)
+{
+    std::size_t const offset = fsc_instrument::aligned_offset(al);
+    std::size_t const total = (offset + n + offset - 1) & ~(offset - 1);
+    void* const p = std::aligned_alloc(offset, total);
+    if (nullptr == p)
+    {
+        throw std::bad_alloc();
+    }
+    char* const r = static_cast<char*>(p) + offset;
+    reinterpret_cast<std::size_t*>(r)[-1] = n;
+    fsc_instrument::on_heap_alloc(n);
+    return r;
+}
+
+void operator delete(void* p, std::align_val_t al) noexcept
+{
+    if (nullptr != p)
+    {
+        fsc_instrument::on_heap_free(static_cast<std::size_t*>(p)[-1]);
+        std::free(static_cast<char*>(p) - fsc_instrument::aligned_offset(al));
+    }
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t al) noexcept
+{
+    operator delete(p, al);
+}
+
+// The array and nothrow forms are replaced too: sanitizer runtimes would otherwise supply their
+// own, whose blocks would then reach the deletes above
+
+void* operator new[](std::size_t n)
+{
+    return operator new(n);
+}
+
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+void* operator new[](std::size_t n, std::align_val_t al)
+{
+    return operator new(n, al);
+}
+
+void operator delete[](void* p, std::align_val_t al) noexcept
+{
+    operator delete(p, al);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t al) noexcept
+{
+    operator delete(p, al);
+}
+
+void* operator new(std::size_t n, std::nothrow_t const&) noexcept
+{
+    try
+    {
+        return operator new(n);
+    }
+    catch (std::bad_alloc const&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t n, std::nothrow_t const&) noexcept
+{
+    return operator new(n, std::nothrow);
+}
+
+void* operator new(std::size_t n, std::align_val_t al, std::nothrow_t const&) noexcept
+{
+    try
+    {
+        return operator new(n, al);
+    }
+    catch (std::bad_alloc const&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t n, std::align_val_t al, std::nothrow_t const&) noexcept
+{
+    return operator new(n, al, std::nothrow);
+}
+
+void operator delete(void* p, std::nothrow_t const&) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void* p, std::nothrow_t const&) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void* p, std::align_val_t al, std::nothrow_t const&) noexcept
+{
+    operator delete(p, al);
+}
+
+void operator delete[](void* p, std::align_val_t al, std::nothrow_t const&) noexcept
+{
+    operator delete(p, al);
+}
+
+#endif
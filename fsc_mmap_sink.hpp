@@ -0,0 +1,187 @@
+#ifndef FSC_MMAP_SINK_HPP
+#define FSC_MMAP_SINK_HPP
+
+// Output file written through a growing memory mapping.
+//
+// Each concatenation reserves exactly length() bytes of the mapped region and
+// has its fragments copied straight into it, so there is neither a temporary
+// string nor a user-space stream buffer. The file is grown by doubling (one
+// posix_fallocate(), or ftruncate() where that is unavailable, and one remap
+// per growth) and trimmed to the written size when closed. Allocating the
+// blocks up front means a full disk is reported by append() as ENOSPC rather
+// than by a SIGBUS on a later store into the mapping. POSIX only.
+
+#include <cerrno>
+#include <cstddef>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "fsc_copy.hpp"
+
+namespace stlsoft
+{
+    class fsc_mmap_sink
+    {
+    public:
+        /// Creates or truncates the file at path
+        ///
+        /// \param initial Size of the first mapping; growth doubles the mapping from there
+        /// \throws std::system_error if the file cannot be created or mapped
+        explicit fsc_mmap_sink(char const* path, std::size_t initial = 1 << 20)
+                : fd_(::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644))
+        {
+            if (fd_ < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "fsc_mmap_sink: open");
+            }
+            try
+            {
+                grow(initial < page_size() ? page_size() : initial);
+            }
+            catch (...)
+            {
+                ::close(fd_);
+                throw;
+            }
+        }
+        ~fsc_mmap_sink()
+        {
+            try
+            {
+                close();
+            }
+            catch (std::system_error const&)
+            {}
+        }
+        fsc_mmap_sink(const fsc_mmap_sink&) = delete;
+        fsc_mmap_sink& operator=(const fsc_mmap_sink&) = delete;
+
+        /// Appends a concatenation (stack or safe) without materializing it
+        ///
+        /// \throws std::logic_error if the sink has been closed
+        /// \throws std::system_error if the file cannot be grown or remapped
+        template <class T>
+        void append(T const& fsc)
+        {
+            if (fd_ < 0)
+            {
+                throw std::logic_error("fsc_mmap_sink: append after close");
+            }
+
+            std::size_t const n = fsc.length();
+
+            if (size_ + n > capacity_)
+            {
+                std::size_t want = (0 != capacity_) ? capacity_ * 2 : page_size();
+                while (want < size_ + n)
+                {
+                    want *= 2;
+                }
+                grow(want);
+            }
+
+            char* out = base_ + size_;
+            auto copy = [&out](auto const& fragment)
+            {
+                out = fsc_detail::copy_bytes(out, fragment.s, fragment.len);
+            };
+            fsc.for_each_fragment(copy);
+            size_ += n;
+        }
+
+        /// Bytes written so far; zero once closed
+        [[nodiscard]] std::size_t size() const noexcept {return size_;}
+
+        /// Unmaps and trims the file to size(); called by the destructor if not called explicitly
+        void close()
+        {
+            if (fd_ < 0)
+            {
+                return;
+            }
+            int const fd = fd_;
+            std::size_t const size = size_;
+            fd_ = -1;
+            if (nullptr != base_)
+            {
+                ::munmap(base_, capacity_);
+            }
+            base_ = nullptr;
+            capacity_ = 0;
+            size_ = 0;
+            bool const trimmed = 0 == ::ftruncate(fd, static_cast<off_t>(size));
+            int const error = errno;
+            ::close(fd);
+            if (!trimmed)
+            {
+                throw std::system_error(error, std::generic_category(), "fsc_mmap_sink: ftruncate");
+            }
+        }
+
+    private:
+        static std::size_t page_size() noexcept
+        {
+            return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        }
+
+        void grow(std::size_t capacity)
+        {
+#if defined(_POSIX_ADVISORY_INFO) && (_POSIX_ADVISORY_INFO > 0)
+            // Returns the error rather than setting errno; EINVAL/EOPNOTSUPP mean the file system cannot preallocate
+            int const error = ::posix_fallocate(fd_, static_cast<off_t>(capacity_), static_cast<off_t>(capacity - capacity_));
+
+            if (EINVAL == error || EOPNOTSUPP == error)
+            {
+                extend(capacity);
+            }
+            else if (0 != error)
+            {
+                throw std::system_error(error, std::generic_category(), "fsc_mmap_sink: posix_fallocate");
+            }
+#else
+            extend(capacity);
+#endif
+
+            void* p;
+#if defined(__linux__)
+            p = (nullptr == base_)
+                ? ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)
+                : ::mremap(base_, capacity_, capacity, MREMAP_MAYMOVE);
+#else
+            if (nullptr != base_)
+            {
+                // Written bytes are already in the file, so a failed mmap below leaves an empty, retryable mapping
+                ::munmap(base_, capacity_);
+                base_ = nullptr;
+                capacity_ = 0;
+            }
+            p = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+#endif
+            if (MAP_FAILED == p)
+            {
+                throw std::system_error(errno, std::generic_category(), "fsc_mmap_sink: mmap");
+            }
+            base_ = static_cast<char*>(p);
+            capacity_ = capacity;
+        }
+
+        // Sparse extension, for when the blocks cannot be allocated up front
+        void extend(std::size_t capacity)
+        {
+            if (0 != ::ftruncate(fd_, static_cast<off_t>(capacity)))
+            {
+                throw std::system_error(errno, std::generic_category(), "fsc_mmap_sink: ftruncate");
+            }
+        }
+
+        int             fd_;
+        char*           base_       = nullptr;
+        std::size_t     capacity_   = 0;
+        std::size_t     size_       = 0;
+    };
+} /* namespace stlsoft */
+
+#endif  // FSC_MMAP_SINK_HPP
@@ -0,0 +1,156 @@
+#ifndef FSC_PARALLEL_HPP
+#define FSC_PARALLEL_HPP
+
+// Parallel materialization of very large concatenations.
+//
+// The fragments are flattened, their output offsets computed with a prefix
+// sum, and the output split into equal disjoint ranges that are copied as
+// concurrent tasks; fsc_thread_pool.hpp provides a suitable executor.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <vector>
+#include "fast_string_concatenator.hpp"
+
+namespace stlsoft
+{
+    /// Default minimum number of characters per materialize_parallel() task; concatenations shorter
+    /// than twice this are materialized serially
+    constexpr const std::size_t fsc_parallel_threshold = 256 * 1024;
+
+namespace fsc_detail
+{
+    template<   class S
+            ,   class T
+            ,   class E
+    >
+    inline S materialize_parallel(T const& fsc, E& executor, std::size_t threshold)
+    {
+        typedef typename S::value_type  char_type;
+        typedef std::size_t             size_type;
+
+        struct fragment_type
+        {
+            char_type const*    s;
+            size_type           len;
+        };
+
+        size_type const len     = fsc.length();
+        size_type const workers = executor.concurrency();
+        size_type       parts   = (0 != threshold) ? len / threshold : len;
+
+        if (parts > workers)
+        {
+            parts = workers;
+        }
+        if (parts < 2)
+        {
+            return fsc;
+        }
+
+        std::vector<fragment_type>  fragments;
+        fsc.for_each_fragment([&fragments](auto const& f)
+        {
+            if (0 != f.len)
+            {
+                fragments.push_back(fragment_type{f.s, f.len});
+            }
+        });
+
+        // offsets[i] is where fragments[i] starts in the output
+        std::vector<size_type>      offsets(fragments.size());
+        std::transform_exclusive_scan(fragments.begin(), fragments.end(), offsets.begin(), size_type(0)
+                                    , std::plus<>(), [](fragment_type const& f) { return f.len; });
+
+        S               s(len, '~');
+        char_type*const out = &s[0];
+
+        auto copy_range = [&fragments, &offsets, out](size_type b, size_type e)
+        {
+            size_type i = static_cast<size_type>(std::upper_bound(offsets.begin(), offsets.end(), b) - offsets.begin()) - 1;
+
+            for (; b < e; ++i)
+            {
+                size_type const from    = b - offsets[i];
+                size_type const n       = std::min(fragments[i].len - from, e - b);
+
+                copy_fragment(out + b, fragments[i].s + from, n);
+                b += n;
+            }
+        };
+
+        std::mutex              mx;
+        std::condition_variable done;
+        size_type               pending = parts - 1;
+        size_type const         chunk   = (len + parts - 1) / parts;
+
+        auto wait_for_tasks = [&mx, &done, &pending]
+        {
+            std::unique_lock<std::mutex> lock(mx);
+            done.wait(lock, [&pending] { return 0 == pending; });
+        };
+
+        for (size_type p = 1; p != parts; ++p)
+        {
+            size_type const b = std::min(len, p * chunk);
+            size_type const e = std::min(len, b + chunk);
+
+            try
+            {
+                executor.execute([&copy_range, &mx, &done, &pending, b, e]
+                {
+                    copy_range(b, e);
+                    std::lock_guard<std::mutex> lock(mx);
+                    if (0 == --pending)
+                    {
+                        done.notify_one();
+                    }
+                });
+            }
+            catch (...)
+            {
+                // Tasks already submitted refer to this frame, so they must finish before it unwinds
+                {
+                    std::lock_guard<std::mutex> lock(mx);
+                    pending -= parts - p;
+                }
+                wait_for_tasks();
+                throw;
+            }
+        }
+        copy_range(0, std::min(len, chunk));
+        wait_for_tasks();
+
+        return s;
+    }
+} /* namespace fsc_detail */
+
+    /// Materializes by copying disjoint output ranges concurrently
+    ///
+    /// \param executor Provides <code>concurrency()</code> (the number of tasks it can run at once, counting
+    ///   the calling thread, which copies the first range itself) and <code>execute(f)</code>
+    /// \param threshold Minimum number of characters per task; shorter concatenations are copied serially
+    template<   class S
+            ,   class C
+            ,   class E
+    >
+    [[nodiscard]] inline S materialize_parallel(fast_string_concatenator<S, C> const& fsc, E& executor, std::size_t threshold = fsc_parallel_threshold)
+    {
+        return fsc_detail::materialize_parallel<S>(fsc, executor, threshold);
+    }
+
+    template<   class S
+            ,   std::size_t Size
+            ,   class E
+    >
+    [[nodiscard]] inline S materialize_parallel(concat_ptr_and_alloc<S, Size> const& fsc, E& executor, std::size_t threshold = fsc_parallel_threshold)
+    {
+        return fsc_detail::materialize_parallel<S>(fsc, executor, threshold);
+    }
+} /* namespace stlsoft */
+
+#endif  // FSC_PARALLEL_HPP
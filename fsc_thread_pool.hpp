@@ -0,0 +1,84 @@
+#ifndef FSC_THREAD_POOL_HPP
+#define FSC_THREAD_POOL_HPP
+
+// A minimal fixed-size thread pool satisfying the executor requirements of
+// fast_string_concatenator::materialize_parallel()
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stlsoft
+{
+    class fsc_thread_pool
+    {
+    public:
+        explicit fsc_thread_pool(std::size_t threads = std::thread::hardware_concurrency())
+        {
+            // The caller of materialize_parallel() always works too, so one thread fewer is enough
+            for (std::size_t i = 1; i < threads; ++i)
+            {
+                workers_.emplace_back([this] { run(); });
+            }
+        }
+        ~fsc_thread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mx_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            for (auto& w : workers_)
+            {
+                w.join();
+            }
+        }
+        fsc_thread_pool(const fsc_thread_pool&) = delete;
+        fsc_thread_pool& operator=(const fsc_thread_pool&) = delete;
+
+        /// Number of tasks that may run at once, including the calling thread
+        [[nodiscard]] std::size_t concurrency() const noexcept {return workers_.size() + 1;}
+
+        template <class F>
+        void execute(F&& f)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mx_);
+                tasks_.emplace_back(std::forward<F>(f));
+            }
+            cv_.notify_one();
+        }
+
+    private:
+        void run()
+        {
+            for (;;)
+            {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mx_);
+                    cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                    if (tasks_.empty())
+                    {
+                        return;
+                    }
+                    task = std::move(tasks_.front());
+                    tasks_.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::mutex                          mx_;
+        std::condition_variable             cv_;
+        std::deque<std::function<void()>>   tasks_;
+        std::vector<std::thread>            workers_;
+        bool                                stop_ = false;
+    };
+} /* namespace stlsoft */
+
+#endif  // FSC_THREAD_POOL_HPP
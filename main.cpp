@@ -1,44 +1,36 @@
 //#define STLSOFT_ALLOCATOR_SELECTOR_USE_STLSOFT_NEW_ALLOCATOR
 
+#include "config.h"
+#define FSC_INSTRUMENT_REPLACE_NEW
+#include "fsc_instrument.hpp"
 #include <iostream>
 #include "fast_string_concatenator.hpp"
+#include "fsc_arena_profile.hpp"
 #include <string>
-#include "config.h"
+#include <string_view>
 
 using namespace std;
 using namespace stlsoft;
 
-#if !defined(SANITY_CHECK)
-
-std::size_t memory = 0;
-std::size_t alloc = 0;
-
-void* operator new(std::size_t s) noexcept(false) //noexcept(noexcept(malloc(s)))
-{
-    memory += s;
-    ++alloc;
-    return malloc(s);
-}
-
-void operator delete(void* p) noexcept
-{
-    --alloc;
-    free(p);
-}
-
-#endif
-
 void memuse()
 {
-#if !defined(SANITY_CHECK)
-    std::cout << "memory = " << memory << '\n';
-    std::cout << "alloc = " << alloc << '\n';
+#if defined(FSC_INSTRUMENT)
+    auto const c = fsc_instrument::current();
+    std::cout << "memory = " << c.live_bytes() << '\n';
+    std::cout << "alloc = " << c.live_allocations() << '\n';
+    std::cout << "arena = " << c.arena_bump_hits << " hits, " << c.arena_heap_fallbacks << " heap fallbacks, "
+              << c.arena_high_water << " bytes high water\n";
 #endif
 }
 
 
 using string_class = std::string;
 
+string_class get_name()
+{
+    return "Moon";
+}
+
 template <class T>
 auto transport (T s)
 {
@@ -80,5 +72,19 @@ int main() {
 
     std::cout << result_string << '\n' << result_string2 << '\n';
 
+    // Slicing: only the requested characters are copied
+    string_class page = (fsc_seed()+s1+','+s2+' '+s3+",oh-oh!").slice(8, 11);
+    string_class safe_page = tmp_fsc.slice(14).slice(0, 5);
+    std::cout << page << '\n' << safe_page << '\n';
+
+    // Arena sized for this call site by a profiling build
+    FSC_SITE_ARENA(string_class, "main.farewell", site_arena);
+    string_class farewell = fsc_safe_seed(site_arena)+s1+','+s3;
+    std::cout << farewell << '\n';
+
+    // Temporaries are captured into the arena: short ones copied, long ones moved
+    auto const captured = fsc_safe_seed(arena)+s1+','+get_name()+' '+std::string_view("and stars");
+    std::cout << string_class(captured) << '\n';
+
     return 0;
 }
@@ -26,12 +26,16 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include "fsc_instrument.hpp"
 
 template <std::size_t N, std::size_t alignment = alignof(std::max_align_t)>
 class arena
 {
     alignas(alignment) char buf_[N];
     char* ptr_;
+#if defined(FSC_ARENA_PROFILE)
+    std::size_t peak_ = 0;
+#endif
 
 public:
     ~arena() {ptr_ = nullptr;}
@@ -45,6 +49,10 @@ public:
     static constexpr std::size_t size() noexcept {return N;}
     [[nodiscard]] std::size_t used() const noexcept {return static_cast<std::size_t>(ptr_ - buf_);}
     void reset() noexcept {ptr_ = buf_;}
+#if defined(FSC_ARENA_PROFILE)
+    // Most bytes this arena was asked to hold at once, counting requests that spilled to the heap
+    [[nodiscard]] std::size_t peak() const noexcept {return peak_;}
+#endif
 
 private:
     static
@@ -68,12 +76,18 @@ arena<N, alignment>::allocate(std::size_t n)
     static_assert(ReqAlign <= alignment, "alignment is too small for this arena");
     assert(pointer_in_buffer(ptr_) && "short_alloc has outlived arena");
     auto const aligned_n = align_up(n);
+#if defined(FSC_ARENA_PROFILE)
+    if (used() + aligned_n > peak_)
+        peak_ = used() + aligned_n;
+#endif
     if (static_cast<decltype(aligned_n)>(buf_ + N - ptr_) >= aligned_n)
     {
         char* r = ptr_;
         ptr_ += aligned_n;
+        FSC_INSTRUMENT_HOOK(on_arena_bump(used()));
         return r;
     }
+    FSC_INSTRUMENT_HOOK(on_arena_heap_fallback());
 
     static_assert(alignment <= alignof(std::max_align_t), "you've chosen an "
                   "alignment that is larger than alignof(std::max_align_t), and "
@@ -90,7 +104,10 @@ arena<N, alignment>::deallocate(char* p, std::size_t n) noexcept
     {
         n = align_up(n);
         if (p + n == ptr_)
+        {
             ptr_ = p;
+            FSC_INSTRUMENT_HOOK(on_arena_reclaim());
+        }
     }
     else
         ::operator delete(p);